@@ -0,0 +1,10 @@
+TEMPLATE = app
+
+# The benchmark only needs libcurl, it is not installed
+CONFIG -= qt app_bundle
+CONFIG += console
+
+SOURCES += main.cpp
+TARGET = rzl-tlsbench
+
+QMAKE_LFLAGS += -lcurl
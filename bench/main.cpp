@@ -0,0 +1,136 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget — TLS handshake benchmark
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ * Fetches the status a number of times and compares the cost of the TLS
+ * handshake without session resumption, with session resumption (what the
+ * widget does in lean mode) and with a kept-alive connection (what the
+ * widget does otherwise).
+ *
+ * To run it against a local stand-in server:
+ *
+ *   openssl req -x509 -newkey rsa:2048 -nodes -subj /CN=localhost \
+ *       -keyout key.pem -out cert.pem
+ *   mkdir -p api && echo 1 > api/simple
+ *   openssl s_server -accept 4433 -cert cert.pem -key key.pem -WWW &
+ *   rzl-tlsbench https://localhost:4433/api/simple 20 cert.pem
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <curl/curl.h>
+
+enum mode { MODE_FULL, MODE_RESUME, MODE_KEEPALIVE };
+
+static const char *mode_names[] = { "full handshake", "resumed session", "keep-alive" };
+
+struct bench_result {
+    int failed;
+    long connects;
+    double handshake;
+    double total;
+};
+
+static size_t discard(void *buffer, size_t size, size_t nmemb, void *userp) {
+    (void)buffer;
+    (void)userp;
+    return size * nmemb;
+}
+
+static CURL *new_handle(const char *url, const char *cafile, CURLSH *share) {
+    CURL *hdl = curl_easy_init();
+    curl_easy_setopt(hdl, CURLOPT_URL, url);
+    curl_easy_setopt(hdl, CURLOPT_WRITEFUNCTION, discard);
+    curl_easy_setopt(hdl, CURLOPT_TIMEOUT, 30L);
+    if (cafile != NULL)
+        curl_easy_setopt(hdl, CURLOPT_CAINFO, cafile);
+    if (share != NULL)
+        curl_easy_setopt(hdl, CURLOPT_SHARE, share);
+    else curl_easy_setopt(hdl, CURLOPT_SSL_SESSIONID_CACHE, 0L);
+    return hdl;
+}
+
+static struct bench_result run(enum mode mode, const char *url, const char *cafile, int count) {
+    struct bench_result res;
+    memset(&res, 0, sizeof(res));
+
+    CURLSH *share = NULL;
+    if (mode != MODE_FULL) {
+        share = curl_share_init();
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    }
+
+    CURL *hdl = NULL;
+    for (int c = 0; c < count; c++) {
+        /* Without keep-alive, every update uses a new handle (and therefore
+         * a new connection), like the widget in lean mode */
+        if (hdl == NULL)
+            hdl = new_handle(url, cafile, share);
+
+        if (curl_easy_perform(hdl) != CURLE_OK) {
+            res.failed++;
+        } else {
+            double connect = 0, appconnect = 0, total = 0;
+            long connects = 0;
+            curl_easy_getinfo(hdl, CURLINFO_CONNECT_TIME, &connect);
+            curl_easy_getinfo(hdl, CURLINFO_APPCONNECT_TIME, &appconnect);
+            curl_easy_getinfo(hdl, CURLINFO_TOTAL_TIME, &total);
+            curl_easy_getinfo(hdl, CURLINFO_NUM_CONNECTS, &connects);
+            /* On a reused connection, APPCONNECT_TIME is 0 */
+            if (appconnect > connect)
+                res.handshake += appconnect - connect;
+            res.total += total;
+            res.connects += connects;
+        }
+
+        if (mode != MODE_KEEPALIVE) {
+            curl_easy_cleanup(hdl);
+            hdl = NULL;
+        }
+    }
+
+    if (hdl != NULL)
+        curl_easy_cleanup(hdl);
+    if (share != NULL)
+        curl_share_cleanup(share);
+
+    return res;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Syntax: %s <https-url> [count] [cafile]\n", argv[0]);
+        return 1;
+    }
+
+    const char *url = argv[1];
+    int count = (argc > 2 ? atoi(argv[2]) : 10);
+    const char *cafile = (argc > 3 ? argv[3] : NULL);
+    if (count <= 0)
+        count = 10;
+
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    printf("%-16s %8s %8s %15s %11s\n", "mode", "requests", "connects", "handshake [ms]", "total [ms]");
+    for (int m = MODE_FULL; m <= MODE_KEEPALIVE; m++) {
+        struct bench_result res = run((enum mode)m, url, cafile, count);
+        int ok = count - res.failed;
+        if (ok == 0) {
+            printf("%-16s %8d all requests failed\n", mode_names[m], count);
+            continue;
+        }
+        printf("%-16s %8d %8ld %15.2f %11.2f\n", mode_names[m], ok, res.connects,
+               res.handshake * 1000 / ok, res.total * 1000 / ok);
+    }
+
+    curl_global_cleanup();
+    return 0;
+}
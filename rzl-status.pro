@@ -1,2 +1,14 @@
 TEMPLATE = subdirs
 SUBDIRS = src
+
+# "qmake CONFIG+=tools" also builds the developer tools: the schedule
+# simulator (sim/) and the TLS benchmark (bench/)
+tools {
+    SUBDIRS += sim bench
+}
+
+# "qmake CONFIG+=tests" also builds the tests, run them with
+# "make -C tests check"
+tests {
+    SUBDIRS += tests
+}
@@ -0,0 +1,413 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget — schedule simulator
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ * Replays a trace recorded by the widget (see src/trace.h) against different
+ * update policies in virtual time and reports, for each policy, how many
+ * fetches were made, how often the cellular radio had to be woken up and
+ * how long the widget showed a wrong status.
+ *
+ * The server status transitions in a widget trace are only recorded when
+ * the recording widget fetched them, so they lag behind the real
+ * transitions by up to its update interval. Using them as ground truth
+ * makes the recorded policy look better than it is and undercounts the
+ * staleness of every policy. For accurate numbers, record a ground truth
+ * trace at the same time with probe.sh and pass it with -g.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QDateTime>
+#include <QtAlgorithms>
+
+#include "schedule.h"
+#include "trace.h"
+
+/* A fetch within this many milliseconds after the previous one finished
+ * finds the radio still active (no additional wakeup) */
+#define RADIO_TAIL_MS (15 * 1000)
+
+/* Latency used when the trace contains no fetch on a bearer */
+#define DEFAULT_LATENCY_MS 1000
+
+/* A recorded fetch this close to a simulated one decides whether the
+ * simulated fetch fails */
+#define OUTCOME_WINDOW_MS (5 * 60 * 1000)
+
+enum event_type { EV_CONN, EV_STATS, EV_FETCH, EV_SERVER, EV_DISPLAY };
+
+struct event {
+    qint64 t;
+    event_type type;
+    QString arg;
+    bool ok;
+    int latency;
+};
+
+struct policy {
+    QString name;
+    /* align the first update to the quarter/half hour like the widget */
+    bool aligned;
+    /* otherwise, update every fixed_ms milliseconds */
+    int fixed_ms;
+    /* revalidate when the display turns on */
+    bool on_display;
+};
+
+struct result {
+    int fetches;
+    int wakeups;
+    qint64 stale_ms;
+    qint64 total_ms;
+};
+
+static QList<event> events;
+/* time range of the widget trace */
+static qint64 trace_start;
+static qint64 trace_end;
+static qint64 latency_sum[2];
+static int latency_cnt[2];
+
+static bool is_wlan(const QString &bearer) {
+    return (bearer == "WLAN_INFRA");
+}
+
+static bool event_before(const event &a, const event &b) {
+    return (a.t < b.t);
+}
+
+/*
+ * Loads the events of a trace. With truth_only, only the server status
+ * transitions are loaded (ground truth trace), with skip_server, they are
+ * left out (widget trace when a ground truth trace is used).
+ *
+ */
+static bool load_trace(const char *path, bool truth_only, bool skip_server) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+
+    char line[512];
+    int lineno = 0;
+    QString fetch_bearer;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        QStringList parts = QString(line).trimmed().split(' ', QString::SkipEmptyParts);
+        if (parts.isEmpty() || parts[0].startsWith("#"))
+            continue;
+        if (parts.size() < 3) {
+            fprintf(stderr, "%s:%d: invalid line\n", path, lineno);
+            continue;
+        }
+
+        event ev;
+        ev.t = parts[0].toLongLong();
+        ev.arg = parts[2];
+        ev.ok = true;
+        ev.latency = 0;
+        if (parts[1] == "conn")
+            ev.type = EV_CONN;
+        else if (parts[1] == "stats")
+            ev.type = EV_STATS;
+        else if (parts[1] == "server")
+            ev.type = EV_SERVER;
+        else if (parts[1] == "display")
+            ev.type = EV_DISPLAY;
+        else if (parts[1] == "fetch" && parts.size() >= 5) {
+            ev.type = EV_FETCH;
+            ev.ok = (parts[2] == "ok");
+            ev.latency = parts[3].toInt();
+            ev.arg = parts[4];
+            /* remember the latency per kind of bearer */
+            if (!truth_only) {
+                int kind = (is_wlan(fetch_bearer) ? 1 : 0);
+                latency_sum[kind] += ev.latency;
+                latency_cnt[kind]++;
+            }
+        } else {
+            fprintf(stderr, "%s:%d: unknown event \"%s\"\n", path, lineno,
+                    parts[1].toAscii().data());
+            continue;
+        }
+
+        if (ev.type == EV_CONN || ev.type == EV_STATS)
+            fetch_bearer = ev.arg;
+
+        if ((truth_only && ev.type != EV_SERVER) || (skip_server && ev.type == EV_SERVER))
+            continue;
+
+        events.append(ev);
+    }
+    fclose(f);
+
+    return !events.isEmpty();
+}
+
+static int latency_for(const QString &bearer) {
+    int kind = (is_wlan(bearer) ? 1 : 0);
+    if (latency_cnt[kind] == 0)
+        return DEFAULT_LATENCY_MS;
+    return latency_sum[kind] / latency_cnt[kind];
+}
+
+/*
+ * A simulated fetch fails if the recorded fetch closest to it failed.
+ *
+ */
+static bool fetch_succeeds(qint64 t) {
+    qint64 best = OUTCOME_WINDOW_MS + 1;
+    bool ok = true;
+    for (int c = 0; c < events.size(); c++) {
+        if (events[c].type != EV_FETCH)
+            continue;
+        qint64 d = qAbs(events[c].t - t);
+        if (d < best) {
+            best = d;
+            ok = events[c].ok;
+        }
+    }
+    return ok;
+}
+
+static QTime local_time(qint64 t) {
+    return QDateTime::fromTime_t(t / 1000).time().addMSecs(t % 1000);
+}
+
+static result simulate(const policy &pol) {
+    result res;
+    memset(&res, 0, sizeof(res));
+
+    /* The server status at the start is the last transition before it. If
+     * there is none, we assume it is what the first transition reports. */
+    QString truth = "?";
+    for (int c = 0; c < events.size(); c++) {
+        if (events[c].type != EV_SERVER)
+            continue;
+        if (events[c].t > trace_start && truth != "?")
+            break;
+        truth = events[c].arg;
+    }
+
+    QString bearer;
+    QString shown = "?";
+    qint64 now = trace_start;
+    qint64 end = trace_end;
+    qint64 timer_due = -1;
+    qint64 interval = 0;
+    qint64 pending_due = -1;
+    QString pending_status;
+    QString pending_bearer;
+    qint64 radio_idle_at = -1;
+    qint64 last_fetched = -1;
+    qint64 last_finished = -1;
+    bool last_succeeded = false;
+    /* a fetch was triggered while another one was running */
+    bool queued = false;
+    QString last_fetch_bearer;
+    int next_ev = 0;
+    while (next_ev < events.size() && events[next_ev].t < now)
+        next_ev++;
+
+    res.total_ms = end - now;
+
+    while (true) {
+        /* find out what happens next: a trace event, the update timer or
+         * the end of a running fetch */
+        qint64 t = -1;
+        int what = -1;
+        if (next_ev < events.size()) {
+            t = events[next_ev].t;
+            what = 0;
+        }
+        if (timer_due >= 0 && (t < 0 || timer_due < t)) {
+            t = timer_due;
+            what = 1;
+        }
+        if (pending_due >= 0 && (t < 0 || pending_due <= t)) {
+            t = pending_due;
+            what = 2;
+        }
+        if (t < 0 || t > end)
+            break;
+
+        if (shown != truth)
+            res.stale_ms += t - now;
+        now = t;
+
+        bool fetch = false;
+        if (what == 2) {
+            shown = pending_status;
+            if (shown != "?")
+                last_fetched = now;
+            last_finished = now;
+            last_succeeded = (shown != "?");
+            last_fetch_bearer = pending_bearer;
+            pending_due = -1;
+            /* the triggers queued during the fetch are handled now, they
+             * collapse into one (offline, there is nothing to fetch) */
+            fetch = (queued && rzl_is_online(bearer));
+            queued = false;
+        } else if (what == 1) {
+            fetch = true;
+            timer_due = now + interval;
+        } else {
+            const event &ev = events[next_ev++];
+            switch (ev.type) {
+                case EV_CONN:
+                case EV_STATS:
+                    if (ev.arg == bearer)
+                        break;
+                    bearer = ev.arg;
+                    if (!rzl_is_online(bearer)) {
+                        timer_due = -1;
+                        break;
+                    }
+                    if (pol.aligned) {
+                        interval = rzl_update_interval(bearer);
+                        timer_due = now + rzl_first_update_delay(local_time(now), bearer);
+                    } else {
+                        interval = pol.fixed_ms;
+                        timer_due = now + interval;
+                    }
+                    fetch = true;
+                    break;
+                case EV_SERVER:
+                    truth = ev.arg;
+                    break;
+                case EV_DISPLAY:
+                    if (!pol.on_display)
+                        break;
+                    fetch = rzl_should_revalidate(bearer, (last_fetched >= 0 ? now - last_fetched : -1));
+                    break;
+                case EV_FETCH:
+                    /* recorded fetches only provide latencies and outcomes */
+                    break;
+            }
+        }
+
+        if (!fetch)
+            continue;
+
+        /* fetches block the widget, so a trigger during a fetch is only
+         * handled after it finished */
+        if (pending_due >= 0) {
+            queued = true;
+            continue;
+        }
+
+        /* like the widget, reuse the result of an update that just finished */
+        if (rzl_in_cooldown((last_finished >= 0 ? now - last_finished : -1),
+                            last_succeeded, last_fetch_bearer, bearer))
+            continue;
+
+        int latency = latency_for(bearer);
+        res.fetches++;
+        if (!is_wlan(bearer)) {
+            if (radio_idle_at < 0 || now > radio_idle_at)
+                res.wakeups++;
+            radio_idle_at = now + latency + RADIO_TAIL_MS;
+        }
+        pending_due = now + latency;
+        pending_status = (fetch_succeeds(now) ? truth : QString("?"));
+        pending_bearer = bearer;
+    }
+
+    if (shown != truth)
+        res.stale_ms += end - now;
+
+    return res;
+}
+
+static bool parse_policy(const char *spec, policy *pol) {
+    pol->name = spec;
+    pol->aligned = false;
+    pol->fixed_ms = 0;
+    pol->on_display = false;
+
+    if (strcmp(spec, "widget") == 0) {
+        pol->aligned = true;
+        return true;
+    }
+    if (strcmp(spec, "display") == 0) {
+        pol->aligned = true;
+        pol->on_display = true;
+        return true;
+    }
+    if (strncmp(spec, "fixed-", strlen("fixed-")) == 0) {
+        int minutes = atoi(spec + strlen("fixed-"));
+        if (minutes <= 0)
+            return false;
+        pol->fixed_ms = minutes * 60 * 1000;
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    const char *truth_path = NULL;
+    int first = 1;
+    if (argc > 1 && strcmp(argv[1], "-g") == 0) {
+        truth_path = (argc > 2 ? argv[2] : NULL);
+        first = 3;
+    }
+
+    if (argc <= first) {
+        fprintf(stderr, "Syntax: %s [-g <ground truth trace>] <trace> [policy…]\n", argv[0]);
+        fprintf(stderr, "Policies: widget, display, fixed-<minutes>\n");
+        return 1;
+    }
+
+    if (!load_trace(argv[first], false, truth_path != NULL))
+        return 1;
+    trace_start = events.first().t;
+    trace_end = events.last().t;
+
+    if (truth_path != NULL) {
+        if (!load_trace(truth_path, true, false))
+            return 1;
+        qStableSort(events.begin(), events.end(), event_before);
+    }
+
+    QList<policy> policies;
+    const char *defaults[] = { "widget", "display", "fixed-5", "fixed-60" };
+    for (int c = first + 1; c < argc; c++) {
+        policy pol;
+        if (!parse_policy(argv[c], &pol)) {
+            fprintf(stderr, "Unknown policy \"%s\"\n", argv[c]);
+            return 1;
+        }
+        policies.append(pol);
+    }
+    if (policies.isEmpty())
+        for (unsigned int c = 0; c < sizeof(defaults) / sizeof(defaults[0]); c++) {
+            policy pol;
+            parse_policy(defaults[c], &pol);
+            policies.append(pol);
+        }
+
+    if (truth_path != NULL)
+        printf("# ground truth: %s\n", truth_path);
+    else printf("# ground truth: server transitions seen by the recording widget, they lag\n"
+                "# behind reality, so staleness is undercounted (use -g with a probe trace)\n");
+    printf("%-12s %8s %8s %10s %7s\n", "policy", "fetches", "wakeups", "stale [s]", "stale");
+    for (int c = 0; c < policies.size(); c++) {
+        result res = simulate(policies[c]);
+        double pct = (res.total_ms > 0 ? 100.0 * res.stale_ms / res.total_ms : 0.0);
+        printf("%-12s %8d %8d %10lld %6.2f%%\n", policies[c].name.toAscii().data(),
+               res.fetches, res.wakeups, res.stale_ms / 1000, pct);
+    }
+
+    return 0;
+}
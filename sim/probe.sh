@@ -0,0 +1,26 @@
+#!/bin/sh
+#
+# Records a ground truth trace for rzl-sim: polls the status every few
+# seconds and writes a "server" event (see src/trace.h) whenever it changes.
+# Run it next to a widget recording a trace, e.g. on a machine with a fixed
+# network connection:
+#
+#   sim/probe.sh 10 > truth.trace
+#   rzl-sim -g truth.trace widget.trace
+#
+set -e
+
+INTERVAL=${1:-10}
+URL=${2:-http://status.raumzeitlabor.de/api/simple}
+
+echo "# rzl-trace 1"
+last=""
+while true; do
+    status=$(curl -s -m 5 -H "Cache-Control: no-cache" "$URL" | cut -c1)
+    [ -z "$status" ] && status="?"
+    if [ "$status" != "$last" ]; then
+        echo "$(date +%s%3N) server $status"
+        last="$status"
+    fi
+    sleep "$INTERVAL"
+done
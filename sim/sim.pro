@@ -0,0 +1,11 @@
+TEMPLATE = app
+
+# The simulator only needs QtCore, it is not installed
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../src
+SOURCES += main.cpp ../src/schedule.cpp
+HEADERS += ../src/schedule.h ../src/trace.h
+TARGET = rzl-sim
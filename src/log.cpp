@@ -0,0 +1,233 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+
+#include "log.h"
+
+struct log_record {
+    struct timeval tv;
+    int level;
+    char msg[LOG_MSG_SIZE];
+};
+
+volatile sig_atomic_t rzl_log_level = LOG_ERR;
+/* level from the environment, restored by SIGUSR2 */
+static volatile sig_atomic_t initial_level = LOG_ERR;
+
+static struct log_record ring[LOG_RING_SIZE];
+/* index of the oldest pending record and number of pending records */
+static int ring_start = 0;
+static int ring_count = 0;
+static int ring_dropped = 0;
+/* when the oldest pending record arrived, the flush deadline counts from here */
+static struct timespec first_pending;
+
+static pthread_mutex_t ring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ring_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t flush_thread;
+static bool running = false;
+static FILE *log_file = NULL;
+
+static void write_records(struct log_record *records, int count, int dropped) {
+    if (dropped > 0) {
+        if (log_file != NULL)
+            fprintf(log_file, "(%d log messages dropped)\n", dropped);
+        else syslog(LOG_WARNING, "(%d log messages dropped)", dropped);
+    }
+
+    for (int c = 0; c < count; c++) {
+        if (log_file == NULL) {
+            syslog(records[c].level, "%s", records[c].msg);
+            continue;
+        }
+
+        char stamp[32];
+        time_t sec = records[c].tv.tv_sec;
+        struct tm tm;
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime_r(&sec, &tm));
+        fprintf(log_file, "%s.%03d %s\n", stamp, (int)(records[c].tv.tv_usec / 1000),
+                records[c].msg);
+    }
+
+    if (log_file != NULL)
+        fflush(log_file);
+}
+
+/*
+ * Takes all pending records out of the ring buffer and writes them. Must be
+ * called with ring_mutex held, the lock is released while writing.
+ *
+ */
+static void flush_locked() {
+    static struct log_record batch[LOG_RING_SIZE];
+    int count = ring_count;
+    int dropped = ring_dropped;
+
+    for (int c = 0; c < count; c++)
+        batch[c] = ring[(ring_start + c) % LOG_RING_SIZE];
+    ring_start = (ring_start + count) % LOG_RING_SIZE;
+    ring_count = 0;
+    ring_dropped = 0;
+
+    if (count == 0 && dropped == 0)
+        return;
+
+    pthread_mutex_unlock(&ring_mutex);
+    write_records(batch, count, dropped);
+    pthread_mutex_lock(&ring_mutex);
+}
+
+static void *flush_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&ring_mutex);
+    while (running) {
+        /* Sleep without a timeout while there is nothing to write, so that an
+         * idle widget does not wake up the CPU every LOG_FLUSH_SECS */
+        while (running && ring_count == 0)
+            pthread_cond_wait(&ring_cond, &ring_mutex);
+
+        struct timespec deadline = first_pending;
+        deadline.tv_sec += LOG_FLUSH_SECS;
+
+        /* Wake up early when the ring buffer is half full */
+        while (running && ring_count < LOG_RING_SIZE / 2)
+            if (pthread_cond_timedwait(&ring_cond, &ring_mutex, &deadline) == ETIMEDOUT)
+                break;
+
+        flush_locked();
+    }
+    flush_locked();
+    pthread_mutex_unlock(&ring_mutex);
+
+    return NULL;
+}
+
+/*
+ * SIGUSR1 switches to the next log level, SIGUSR2 goes back to the initial
+ * one. Only async-signal-safe assignments happen here.
+ *
+ */
+static void level_signal(int sig) {
+    if (sig == SIGUSR2) {
+        rzl_log_level = initial_level;
+        return;
+    }
+
+    switch (rzl_log_level) {
+        case LOG_ERR:
+            rzl_log_level = LOG_INFO;
+            break;
+        case LOG_INFO:
+            rzl_log_level = LOG_DEBUG;
+            break;
+        case LOG_DEBUG:
+            rzl_log_level = -1;
+            break;
+        default:
+            rzl_log_level = LOG_ERR;
+    }
+}
+
+void rzl_log_init() {
+    const char *level = getenv("RZL_LOG_LEVEL");
+    if (level != NULL) {
+        if (strcmp(level, "off") == 0)
+            rzl_log_set_level(-1);
+        else if (strcmp(level, "err") == 0)
+            rzl_log_set_level(LOG_ERR);
+        else if (strcmp(level, "info") == 0)
+            rzl_log_set_level(LOG_INFO);
+        else if (strcmp(level, "debug") == 0)
+            rzl_log_set_level(LOG_DEBUG);
+    }
+    initial_level = rzl_log_level;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = level_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+    sigaction(SIGUSR2, &action, NULL);
+
+    const char *path = getenv("RZL_LOG_FILE");
+    if (path != NULL && *path != '\0')
+        log_file = fopen(path, "a");
+    if (log_file == NULL)
+        openlog("raumzeitlabor-status", LOG_PID, LOG_USER);
+
+    running = true;
+    if (pthread_create(&flush_thread, NULL, flush_main, NULL) != 0)
+        running = false;
+}
+
+void rzl_log_close() {
+    pthread_mutex_lock(&ring_mutex);
+    bool was_running = running;
+    running = false;
+    pthread_cond_signal(&ring_cond);
+    pthread_mutex_unlock(&ring_mutex);
+
+    if (was_running)
+        pthread_join(flush_thread, NULL);
+
+    /* Without a flush thread, pending records are written now */
+    pthread_mutex_lock(&ring_mutex);
+    flush_locked();
+    pthread_mutex_unlock(&ring_mutex);
+
+    if (log_file != NULL) {
+        fclose(log_file);
+        log_file = NULL;
+    } else closelog();
+}
+
+void rzl_log_set_level(int level) {
+    rzl_log_level = level;
+}
+
+void rzl_log_write(int level, const char *fmt, ...) {
+    pthread_mutex_lock(&ring_mutex);
+
+    /* When the ring buffer is full, the oldest record is overwritten */
+    if (ring_count == LOG_RING_SIZE) {
+        ring_start = (ring_start + 1) % LOG_RING_SIZE;
+        ring_count--;
+        ring_dropped++;
+    }
+
+    struct log_record *rec = &ring[(ring_start + ring_count) % LOG_RING_SIZE];
+    gettimeofday(&rec->tv, NULL);
+    rec->level = level;
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(rec->msg, sizeof(rec->msg), fmt, args);
+    va_end(args);
+
+    /* The first pending record starts the flush deadline, the flush thread
+     * also needs to be woken up when the ring buffer is half full */
+    if (ring_count == 0)
+        clock_gettime(CLOCK_REALTIME, &first_pending);
+    ring_count++;
+    if (ring_count == 1 || ring_count >= LOG_RING_SIZE / 2)
+        pthread_cond_signal(&ring_cond);
+
+    pthread_mutex_unlock(&ring_mutex);
+}
@@ -0,0 +1,71 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#ifndef LOG_H
+#define LOG_H
+
+#include <syslog.h>
+#include <signal.h>
+
+/*
+ * Logging without blocking the GUI thread: messages are formatted into a
+ * ring buffer of fixed-size records, a background thread writes them to
+ * syslog (or to the file in RZL_LOG_FILE) in batches.
+ *
+ * The log level is read from RZL_LOG_LEVEL (off, err, info or debug) and
+ * defaults to err. At runtime, SIGUSR1 switches to the next level
+ * (off → err → info → debug → off) and SIGUSR2 goes back to the level from
+ * the environment:
+ *
+ *   killall -USR1 raumzeitlabor-status
+ *
+ * Messages above the current level cost one comparison, their arguments
+ * are not evaluated.
+ *
+ */
+
+/* Size of a record, longer messages are truncated */
+#define LOG_MSG_SIZE 128
+/* Number of records in the ring buffer, the oldest ones are dropped */
+#define LOG_RING_SIZE 64
+/* Pending records are flushed at least this often (in seconds) */
+#define LOG_FLUSH_SECS 5
+
+/* Log level (LOG_ERR, LOG_INFO, LOG_DEBUG), -1 means off. Changed by the
+ * signal handler, which may run in any thread. */
+extern volatile sig_atomic_t rzl_log_level;
+
+#define RZL_LOG(level, ...) \
+    do { \
+        if ((level) <= rzl_log_level) \
+            rzl_log_write((level), __VA_ARGS__); \
+    } while (0)
+
+#define RZL_LOG_ERR(...) RZL_LOG(LOG_ERR, __VA_ARGS__)
+#define RZL_LOG_INFO(...) RZL_LOG(LOG_INFO, __VA_ARGS__)
+#define RZL_LOG_DEBUG(...) RZL_LOG(LOG_DEBUG, __VA_ARGS__)
+
+/*
+ * Reads the log level and destination from the environment, installs the
+ * signal handlers and starts the flush thread.
+ *
+ */
+void rzl_log_init();
+
+/*
+ * Flushes all pending records and stops the flush thread.
+ *
+ */
+void rzl_log_close();
+
+void rzl_log_set_level(int level);
+void rzl_log_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+#endif
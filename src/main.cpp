@@ -41,6 +41,7 @@
 
 #include "qmaemo5homescreenadaptor.h"
 #include "rzlwidget.h"
+#include "log.h"
 
 #include <QApplication>
 
@@ -48,9 +49,13 @@ int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+    rzl_log_init();
+
     RZLWidget w;
     new QMaemo5HomescreenAdaptor(&w);
     w.show();
 
     app.exec();
+
+    rzl_log_close();
 }
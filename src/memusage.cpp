@@ -0,0 +1,53 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#include <stdio.h>
+#include <unistd.h>
+#include <malloc.h>
+
+#include "memusage.h"
+
+bool rzl_memory_usage(struct rzl_memusage *usage) {
+    /* mallinfo() is deprecated since glibc 2.33 */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+#else
+    struct mallinfo mi = mallinfo();
+#endif
+    usage->heap_kb = mi.uordblks / 1024;
+    usage->rss_kb = -1;
+
+    /* /proc/self/statm contains the sizes in pages, the second field is the
+     * resident set size */
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f == NULL)
+        return false;
+
+    long size, resident;
+    int n = fscanf(f, "%ld %ld", &size, &resident);
+    fclose(f);
+    if (n != 2)
+        return false;
+
+    usage->rss_kb = resident * (sysconf(_SC_PAGESIZE) / 1024);
+    return true;
+}
+
+bool rzl_memory_within_budget(long budget_kb) {
+    struct rzl_memusage usage;
+    if (!rzl_memory_usage(&usage))
+        return false;
+
+    return (usage.rss_kb <= budget_kb);
+}
+
+void rzl_memory_trim() {
+    malloc_trim(0);
+}
@@ -0,0 +1,56 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#ifndef MEMUSAGE_H
+#define MEMUSAGE_H
+
+/*
+ * How far (in kilobytes) the resident set size may grow beyond the size
+ * measured after the first update before the widget logs an error. The
+ * budget is relative because the RSS mostly consists of the shared Qt, curl
+ * and OpenSSL pages, which differ between devices and firmware versions.
+ * RZL_RSS_BUDGET_KB in the environment sets an absolute budget instead.
+ *
+ */
+#define RSS_GROWTH_KB 2048
+
+/*
+ * Memory footprint of the widget process, in kilobytes. rss_kb is the
+ * resident set size as reported by the kernel, heap_kb is the amount of heap
+ * memory currently handed out by malloc.
+ *
+ */
+struct rzl_memusage {
+    long rss_kb;
+    long heap_kb;
+};
+
+/*
+ * Fills in the current memory usage. Returns false if /proc could not be
+ * read (rss_kb is -1 in that case, heap_kb is always filled in).
+ *
+ */
+bool rzl_memory_usage(struct rzl_memusage *usage);
+
+/*
+ * Returns true if the resident set size is at most budget_kb kilobytes.
+ * Intended as a hook for tests and for the debug log.
+ *
+ */
+bool rzl_memory_within_budget(long budget_kb);
+
+/*
+ * Gives free heap memory back to the kernel (e.g. after a transfer buffer
+ * was released).
+ *
+ */
+void rzl_memory_trim();
+
+#endif
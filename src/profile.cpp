@@ -0,0 +1,62 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#include <stdio.h>
+
+#include "profile.h"
+
+/* GPRS needs considerably longer to set up a connection than WLAN */
+static struct transfer_profile profile_wlan = { "wlan", 10, 30, false, false, 0, 0, 0, 0, 0, 0 };
+static struct transfer_profile profile_cellular = { "cellular", 30, 60, true, true, 0, 0, 0, 0, 0, 0 };
+
+struct transfer_profile *rzl_profile_for(const QString &bearer) {
+    /* If the bearer is not known yet, we assume the best */
+    if (bearer.isEmpty() || bearer == "WLAN_INFRA")
+        return &profile_wlan;
+
+    return &profile_cellular;
+}
+
+void rzl_profile_account(struct transfer_profile *profile, CURL *hdl, CURLcode result) {
+    long request_size = 0, header_size = 0, code = 0;
+    double total_time = 0;
+
+    curl_easy_getinfo(hdl, CURLINFO_REQUEST_SIZE, &request_size);
+    curl_easy_getinfo(hdl, CURLINFO_HEADER_SIZE, &header_size);
+    /* CURLINFO_SIZE_DOWNLOAD is deprecated since libcurl 7.55.0 */
+#if LIBCURL_VERSION_NUM >= 0x073700
+    curl_off_t body_size = 0;
+    curl_easy_getinfo(hdl, CURLINFO_SIZE_DOWNLOAD_T, &body_size);
+#else
+    double body_size = 0;
+    curl_easy_getinfo(hdl, CURLINFO_SIZE_DOWNLOAD, &body_size);
+#endif
+    curl_easy_getinfo(hdl, CURLINFO_TOTAL_TIME, &total_time);
+    curl_easy_getinfo(hdl, CURLINFO_RESPONSE_CODE, &code);
+
+    profile->requests++;
+    if (result != CURLE_OK)
+        profile->failed++;
+    else if (code == 304)
+        profile->not_modified++;
+    profile->bytes_sent += request_size;
+    profile->bytes_received += header_size + (long)body_size;
+    profile->total_time += total_time;
+}
+
+void rzl_profile_report(const struct transfer_profile *profile, char *buf, size_t len) {
+    long requests = (profile->requests > 0 ? profile->requests : 1);
+
+    snprintf(buf, len, "%s: %ld requests (%ld not modified, %ld failed), "
+             "%ld bytes sent, %ld bytes received, %.0f ms average latency",
+             profile->name, profile->requests, profile->not_modified, profile->failed,
+             profile->bytes_sent, profile->bytes_received,
+             profile->total_time * 1000 / requests);
+}
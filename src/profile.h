@@ -0,0 +1,63 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stddef.h>
+#include <QString>
+#include <curl/curl.h>
+
+/*
+ * How the status is requested on a given kind of bearer. On wireless, we
+ * send the full request. On cellular connections (GPRS, UMTS, …), every byte
+ * and every round trip counts, so we only send the headers we really need
+ * and ask the server whether the status changed since the last update.
+ *
+ */
+struct transfer_profile {
+    const char *name;
+    /* timeouts in seconds */
+    long connect_timeout;
+    long timeout;
+    /* send only Cache-Control: no-cache and no Accept header */
+    bool lean_headers;
+    /* send If-Modified-Since when the server sent a Last-Modified before */
+    bool conditional;
+
+    /* statistics, see rzl_profile_account() */
+    long requests;
+    long not_modified;
+    long failed;
+    long bytes_sent;
+    long bytes_received;
+    double total_time;
+};
+
+/*
+ * Returns the profile to use on the given bearer.
+ *
+ */
+struct transfer_profile *rzl_profile_for(const QString &bearer);
+
+/*
+ * Adds the statistics of the last transfer on hdl to the profile.
+ *
+ */
+void rzl_profile_account(struct transfer_profile *profile, CURL *hdl, CURLcode result);
+
+/*
+ * Formats a one-line report (requests, bytes, average latency) of the
+ * profile into buf.
+ *
+ */
+void rzl_profile_report(const struct transfer_profile *profile, char *buf, size_t len);
+
+#endif
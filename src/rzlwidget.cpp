@@ -9,12 +9,37 @@
  * See LICENSE for licensing information
  *
  */
-#define DEBUG 1
-#define OSSOLOG_SYSLOG 1
-#include <osso-log.h>
+#include <string.h>
 
 #include <QDateTime>
+#include <QImage>
 #include "rzlwidget.h"
+#include "memusage.h"
+#include "schedule.h"
+#include "trace.h"
+#include "profile.h"
+#include "tlscache.h"
+#include "log.h"
+
+/* "qmake CONFIG+=https" fetches the status via HTTPS */
+#ifdef RZL_HTTPS
+#define STATUS_URL "https://status.raumzeitlabor.de/api/simple"
+#else
+#define STATUS_URL "http://status.raumzeitlabor.de/api/simple"
+#endif
+
+/* An idle connection to the status server is closed after this many
+ * milliseconds, so that the server closing it does not wake up the radio */
+#define KEEPALIVE_MS (30 * 1000)
+
+/* All status icons are 48x48, they are kept side by side in one pixmap */
+#define ICON_SIZE 48
+
+static const char *icon_files[] = {
+    "/usr/share/raumzeitlabor-status-widget/unklar.png",
+    "/usr/share/raumzeitlabor-status-widget/auf.png",
+    "/usr/share/raumzeitlabor-status-widget/zu.png"
+};
 
 /*
  * This signal will be received from icd when the connection status changes.
@@ -29,12 +54,15 @@ static void connection_change(ConIcConnection *connection, ConIcConnectionEvent
     ConIcConnectionStatus status = con_ic_connection_event_get_status(event);
     switch(status) {
         case CON_IC_STATUS_CONNECTED:
+            rzl_trace("conn %s", con_ic_event_get_bearer_type(CON_IC_EVENT(event)));
             w->setConnection(QString(con_ic_event_get_bearer_type(CON_IC_EVENT(event))));
             break;
         case CON_IC_STATUS_DISCONNECTING:
+            rzl_trace("conn offline");
             w->setConnection("offline");
             break;
         case CON_IC_STATUS_DISCONNECTED:
+            rzl_trace("conn offline");
             w->setConnection("offline");
             break;
         default:
@@ -53,9 +81,72 @@ static void connection_statistics(ConIcConnection *connection, ConIcStatisticsEv
     RZLWidget *w = (RZLWidget*)user_data;
 
     /* If the active time is 0, we are offline (bearer is still set) */
-    if (con_ic_statistics_event_get_time_active(event) == 0)
+    if (con_ic_statistics_event_get_time_active(event) == 0) {
+        rzl_trace("stats offline");
         w->setConnection("offline");
-    else w->setConnection(QString(con_ic_event_get_bearer_type(CON_IC_EVENT(event))));
+    } else {
+        rzl_trace("stats %s", con_ic_event_get_bearer_type(CON_IC_EVENT(event)));
+        w->setConnection(QString(con_ic_event_get_bearer_type(CON_IC_EVENT(event))));
+    }
+}
+
+/*
+ * MCE (the mode control entity) broadcasts display and touchscreen/keypad lock
+ * changes on the system bus. When the display turns on or the device gets
+ * unlocked, the user is about to look at the homescreen, so this is a good
+ * moment to refresh the status.
+ *
+ * For testing, DBUS_SYSTEM_BUS_ADDRESS can point to a private bus on which
+ * tests/mce-standin.sh emits these signals (set RZL_BEARER as well, conic
+ * does not work there).
+ *
+ */
+#define MCE_SIGNAL_PATH "/com/nokia/mce/signal"
+#define MCE_SIGNAL_IF "com.nokia.mce.signal"
+#define MCE_DISPLAY_SIG "display_status_ind"
+#define MCE_TKLOCK_MODE_SIG "tklock_mode_ind"
+
+/*
+ * Returns the icon for a status sent by the server.
+ *
+ */
+static int icon_for(const QString &status) {
+    if (status == "1")
+        return ICON_AUF;
+    else if (status == "0")
+        return ICON_ZU;
+    else return ICON_UNKLAR;
+}
+
+/*
+ * Milliseconds since t, -1 if t is invalid (see schedule.h).
+ *
+ */
+static qint64 age_ms(const QDateTime &t) {
+    if (!t.isValid())
+        return -1;
+    return (qint64)t.secsTo(QDateTime::currentDateTime()) * 1000;
+}
+
+static DBusHandlerResult mce_signal(DBusConnection *conn, DBusMessage *msg, void *user_data) {
+    Q_UNUSED(conn);
+    RZLWidget *w = (RZLWidget*)user_data;
+    const char *state = NULL;
+
+    bool display = dbus_message_is_signal(msg, MCE_SIGNAL_IF, MCE_DISPLAY_SIG);
+    bool tklock = dbus_message_is_signal(msg, MCE_SIGNAL_IF, MCE_TKLOCK_MODE_SIG);
+    if (!display && !tklock)
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+    if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &state, DBUS_TYPE_INVALID))
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+    if ((display && strcmp(state, "on") == 0) ||
+        (tklock && strcmp(state, "unlocked") == 0))
+        w->display_on();
+
+    /* Other clients on this connection might be interested, too */
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 }
 
 static size_t recv_status(void *buffer, size_t size, size_t nmemb, void *userp) {
@@ -69,29 +160,72 @@ static size_t recv_status(void *buffer, size_t size, size_t nmemb, void *userp)
     return size * nmemb;
 }
 
-RZLWidget::RZLWidget(QWidget *parent) : QWidget(parent) {
+RZLWidget::RZLWidget(QWidget *parent) : QWidget(parent), hdl(NULL), full_headers(NULL),
+    lean_headers(NULL), lastModified(-1), connection(NULL), interval(0), fetching(false),
+    lastSucceeded(false), fetches(0),
+    saved_reentry(0), saved_cooldown(0), rss_budget_kb(-1), over_budget(false) {
     setAttribute(Qt::WA_TranslucentBackground);
 
-    icon_unklar = new QIcon("/usr/share/raumzeitlabor-status-widget/unklar.png");
-    icon_auf = new QIcon("/usr/share/raumzeitlabor-status-widget/auf.png");
-    icon_zu = new QIcon("/usr/share/raumzeitlabor-status-widget/zu.png");
-    icon = icon_unklar;
-
-    lastUpdated = "?";
-
-    hdl = curl_easy_init();
-
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Pragma: no-cache");
-    headers = curl_slist_append(headers, "Cache-Control: no-cache");
-
-    curl_easy_setopt(hdl, CURLOPT_URL, "http://status.raumzeitlabor.de/api/simple");
-    curl_easy_setopt(hdl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(hdl, CURLOPT_WRITEFUNCTION, recv_status);
-    curl_easy_setopt(hdl, CURLOPT_WRITEDATA, this);
-    curl_easy_setopt(hdl, CURLOPT_ERRORBUFFER, errbuf);
-    /* set a timeout of 30 seconds */
-    curl_easy_setopt(hdl, CURLOPT_TIMEOUT, 30);
+#ifdef RZL_LEAN
+    lean = true;
+#else
+    lean = false;
+#endif
+    /* RZL_LEAN=0 or RZL_LEAN=1 in the environment overrides the default */
+    QByteArray lean_env = qgetenv("RZL_LEAN");
+    if (!lean_env.isEmpty())
+        lean = (lean_env != "0");
+    /* RZL_RSS_BUDGET_KB overrides the budget derived after the first update */
+    bool budget_ok;
+    long budget_env = qgetenv("RZL_RSS_BUDGET_KB").toLong(&budget_ok);
+    if (budget_ok && budget_env > 0)
+        rss_budget_kb = budget_env;
+
+    /* Load the icons once, pre-scaled, into a single pixmap. This is
+     * considerably smaller than keeping one QIcon per status around. */
+    atlas = QPixmap(ICON_COUNT * ICON_SIZE, ICON_SIZE);
+    atlas.fill(Qt::transparent);
+    QPainter ap(&atlas);
+    for (int c = 0; c < ICON_COUNT; c++) {
+        QImage img(icon_files[c]);
+        if (img.isNull())
+            continue;
+        if (img.width() != ICON_SIZE || img.height() != ICON_SIZE)
+            img = img.scaled(ICON_SIZE, ICON_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        ap.drawImage(c * ICON_SIZE, 0, img);
+    }
+    ap.end();
+
+    rzl_trace_open();
+
+    /* RZL_STATUS_URL (and RZL_CA_FILE for its certificate) can point the
+     * widget to a different server, e.g. a local one for testing */
+    url = qgetenv("RZL_STATUS_URL");
+    if (url.isEmpty())
+        url = STATUS_URL;
+    cafile = qgetenv("RZL_CA_FILE");
+
+    /* TLS sessions and DNS lookups are kept in the share object, so they
+     * survive the curl handle being released (lean mode). Resuming a TLS
+     * session saves a full handshake on every update. */
+    share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    /* Sessions from before the last restart, see tlscache.h */
+    rzl_tls_cache_load(share);
+
+    full_headers = curl_slist_append(full_headers, "Pragma: no-cache");
+    full_headers = curl_slist_append(full_headers, "Cache-Control: no-cache");
+
+    /* HTTP/1.1 caches only need Cache-Control. Also, an empty Accept: makes
+     * curl leave out its default Accept header. */
+    lean_headers = curl_slist_append(lean_headers, "Cache-Control: no-cache");
+    lean_headers = curl_slist_append(lean_headers, "Accept:");
+
+    /* In lean mode, the curl handle (and its buffers and connection cache)
+     * only exists while a request is running */
+    if (!lean)
+        setup_curl();
 
     /* Timer will be triggered in setConnection() as soon as the connection
      * status is known */
@@ -102,6 +236,10 @@ RZLWidget::RZLWidget(QWidget *parent) : QWidget(parent) {
     periodic_bearer->start(60 * 1000);
     connect(periodic_bearer, SIGNAL(timeout()), this, SLOT(trigger_periodic()));
 
+    idle_timer = new QTimer(this);
+    idle_timer->setSingleShot(true);
+    connect(idle_timer, SIGNAL(timeout()), this, SLOT(trigger_release()));
+
     /* Setup stuff for the conic library */
     DBusConnection *conn;
     DBusError err;
@@ -113,6 +251,21 @@ RZLWidget::RZLWidget(QWidget *parent) : QWidget(parent) {
 
     dbus_connection_setup_with_g_main(conn, NULL);
 
+    /* Get notified when the display is turned on / the device is unlocked */
+    dbus_bus_add_match(conn, "type='signal',path='" MCE_SIGNAL_PATH "',"
+                             "interface='" MCE_SIGNAL_IF "',member='" MCE_DISPLAY_SIG "'", NULL);
+    dbus_bus_add_match(conn, "type='signal',path='" MCE_SIGNAL_PATH "',"
+                             "interface='" MCE_SIGNAL_IF "',member='" MCE_TKLOCK_MODE_SIG "'", NULL);
+    dbus_connection_add_filter(conn, mce_signal, this, NULL);
+
+    /* RZL_BEARER replaces conic, e.g. for testing on a private bus, where
+     * conic never reports a bearer */
+    QByteArray forced_bearer = qgetenv("RZL_BEARER");
+    if (!forced_bearer.isEmpty()) {
+        setConnection(QString(forced_bearer));
+        return;
+    }
+
     /* We want to get called on connection events */
     connection = con_ic_connection_new();
     g_signal_connect(G_OBJECT(connection), "connection-event", G_CALLBACK(connection_change), this);
@@ -123,6 +276,67 @@ RZLWidget::RZLWidget(QWidget *parent) : QWidget(parent) {
     con_ic_connection_statistics(connection, NULL);
 }
 
+RZLWidget::~RZLWidget() {
+    release_curl();
+    rzl_tls_cache_save(share, true);
+    curl_share_cleanup(share);
+    curl_slist_free_all(full_headers);
+    curl_slist_free_all(lean_headers);
+}
+
+void RZLWidget::setup_curl() {
+    if (hdl != NULL)
+        return;
+
+    hdl = curl_easy_init();
+
+    curl_easy_setopt(hdl, CURLOPT_URL, url.constData());
+    curl_easy_setopt(hdl, CURLOPT_SHARE, share);
+    if (!cafile.isEmpty())
+        curl_easy_setopt(hdl, CURLOPT_CAINFO, cafile.constData());
+    curl_easy_setopt(hdl, CURLOPT_WRITEFUNCTION, recv_status);
+    curl_easy_setopt(hdl, CURLOPT_WRITEDATA, this);
+    curl_easy_setopt(hdl, CURLOPT_ERRORBUFFER, errbuf);
+    /* we need the Last-Modified date for conditional requests */
+    curl_easy_setopt(hdl, CURLOPT_FILETIME, 1L);
+    if (lean) {
+        /* The answer is a single byte, a small receive buffer is plenty */
+        curl_easy_setopt(hdl, CURLOPT_BUFFERSIZE, 1024L);
+        curl_easy_setopt(hdl, CURLOPT_FORBID_REUSE, 1L);
+    } else {
+        /* Keep the connection to the status server open for a short while
+         * (see KEEPALIVE_MS), it is reused when updates are close together
+         * (e.g. a tap right after the timer) */
+        curl_easy_setopt(hdl, CURLOPT_MAXCONNECTS, 1L);
+    }
+}
+
+/*
+ * Sets up the headers, timeouts and conditions for the next request
+ * according to the transfer profile of the current bearer.
+ *
+ */
+void RZLWidget::apply_profile(struct transfer_profile *profile) {
+    curl_easy_setopt(hdl, CURLOPT_HTTPHEADER, (profile->lean_headers ? lean_headers : full_headers));
+    curl_easy_setopt(hdl, CURLOPT_CONNECTTIMEOUT, profile->connect_timeout);
+    curl_easy_setopt(hdl, CURLOPT_TIMEOUT, profile->timeout);
+
+    if (profile->conditional && lastModified >= 0) {
+        curl_easy_setopt(hdl, CURLOPT_TIMECONDITION, (long)CURL_TIMECOND_IFMODSINCE);
+        curl_easy_setopt(hdl, CURLOPT_TIMEVALUE, lastModified);
+    } else {
+        curl_easy_setopt(hdl, CURLOPT_TIMECONDITION, (long)CURL_TIMECOND_NONE);
+    }
+}
+
+void RZLWidget::release_curl() {
+    if (hdl == NULL)
+        return;
+
+    curl_easy_cleanup(hdl);
+    hdl = NULL;
+}
+
 /*
  * Called by connection_change() with the bearer (WLAN_INFRA for wireless,
  * offline when not connected, anything else for some other kind of
@@ -130,72 +344,30 @@ RZLWidget::RZLWidget(QWidget *parent) : QWidget(parent) {
  *
  */
 void RZLWidget::setConnection(QString bearer) {
-    if (lastBearer == bearer)
-        return;
-    ULOG_INFO_L("new bearer: %s", (char*)bearer.toAscii().data());
-    lastBearer = bearer;
-
-    if (bearer == "offline") {
+    StatusSnapshot s;
+    bool changed;
+    do {
+        s = store.read();
+        if (s.bearer == bearer)
+            return;
+        s.bearer = bearer;
+        /* when going offline during an update, show when it was aborted */
+        changed = (bearer == "offline" && s.lastUpdated == "...");
+        if (changed)
+            s.lastUpdated = QString("(%1)").arg(QDateTime::currentDateTime().toString("hh:mm"));
+    } while (!store.publish(s));
+    RZL_LOG_INFO("new bearer: %s", bearer.toAscii().data());
+
+    if (!rzl_is_online(bearer)) {
         timer->stop();
-        if (lastUpdated == "...") {
-            lastUpdated = QString("(%1)").arg(QDateTime::currentDateTime().toString("hh:mm"));
+        if (changed)
             repaint();
-        }
         return;
     }
 
-    /* on wireless, update every 15 minutes */
-    if (bearer == "WLAN_INFRA") {
-        timer->stop();
-        interval = 15 * 60 * 1000;
-
-        QTime next = QTime::currentTime();
-        int min;
-        int hr = next.hour();
-        int sec = 0;
-        int ms = 0;
-        if (next.minute() < 45 && next.minute() >= 30)
-            min = 45;
-        else if (next.minute() < 30 && next.minute() >= 15)
-            min = 30;
-        else if (next.minute() < 15 && next.minute() >= 0)
-            min = 15;
-        else {
-            if (hr == 23) {
-                min = 59;
-                sec = 59;
-                ms = 999;
-            } else {
-                min = 0;
-                hr = hr + 1;
-            }
-        }
-        next.setHMS(hr, min, sec, ms);
-        timer->start(QTime::currentTime().msecsTo(next));
-    }
-    else {
-        /* on data connection, update every 30 minutes */
-        timer->stop();
-        interval = 30 * 60 * 1000;
-
-        QTime next = QTime::currentTime();
-        int min;
-        int hr = next.hour();
-        int sec = 0;
-        int ms = 0;
-        if (next.minute() >= 30) {
-            if (hr == 23) {
-                min = 59;
-                sec = 59;
-                ms = 999;
-            } else {
-                min = 0;
-                hr = hr + 1;
-            }
-        } else min = 30;
-        next.setHMS(hr, min, sec, hr);
-        timer->start(QTime::currentTime().msecsTo(next));
-    }
+    timer->stop();
+    interval = rzl_update_interval(bearer);
+    timer->start(rzl_first_update_delay(QTime::currentTime(), bearer));
 
     /* also trigger an immediate update */
     update();
@@ -204,6 +376,7 @@ void RZLWidget::setConnection(QString bearer) {
 void RZLWidget::paintEvent(QPaintEvent *event) {
     Q_UNUSED(event);
 
+    StatusSnapshot s = store.read();
     QRect r = rect();
     QPainter p(this);
     p.setBrush(QColor(0, 0, 0, 150));
@@ -211,12 +384,31 @@ void RZLWidget::paintEvent(QPaintEvent *event) {
     p.drawRoundedRect(rect(), 15, 15);
     QRect iconrect = QRect(r.x(), 10, r.width(), 50);
 
-    icon->paint(&p, iconrect);
+    p.drawPixmap(iconrect.x() + (iconrect.width() - ICON_SIZE) / 2,
+                 iconrect.y() + (iconrect.height() - ICON_SIZE) / 2,
+                 atlas, s.icon * ICON_SIZE, 0, ICON_SIZE, ICON_SIZE);
 
     p.setPen(QPen(Qt::white));
     QRect lu_rect = QRect(r.x(), 55, r.width(), 30);
 
-    p.drawText(lu_rect, Qt::AlignHCenter, lastUpdated);
+    p.drawText(lu_rect, Qt::AlignHCenter, s.lastUpdated);
+}
+
+/*
+ * Called by mce_signal() when the display turns on or the device gets
+ * unlocked. Revalidates the status unless we are offline or the last
+ * successful update is recent enough.
+ *
+ */
+void RZLWidget::display_on() {
+    rzl_trace("display on");
+
+    StatusSnapshot s = store.read();
+    if (!rzl_should_revalidate(s.bearer, age_ms(s.lastFetched)))
+        return;
+
+    RZL_LOG_INFO("display on, revalidating status");
+    update();
 }
 
 /*
@@ -235,9 +427,22 @@ void RZLWidget::mouseReleaseEvent(QMouseEvent *event) {
  *
  */
 void RZLWidget::trigger_periodic() {
+    if (connection == NULL)
+        return;
+
     con_ic_connection_statistics(connection, NULL);
 }
 
+/*
+ * Closes the connection to the status server KEEPALIVE_MS after the last
+ * update. The TLS session stays in the share object and is resumed by the
+ * next update.
+ *
+ */
+void RZLWidget::trigger_release() {
+    release_curl();
+}
+
 void RZLWidget::trigger_update() {
     if (interval > 0) {
         timer->stop();
@@ -248,31 +453,153 @@ void RZLWidget::trigger_update() {
     update();
 }
 
+/*
+ * Entry point for all updates (tap, timer, bearer change, display on).
+ * Makes sure that only one request is made for a burst of triggers: a
+ * trigger shortly after a successful update on the same bearer reuses its
+ * result. As fetch() blocks, triggers arriving during a request (taps,
+ * bearer changes) are processed right after it and fall into the
+ * cool-down, unless the request failed or the bearer changed. The fetching
+ * flag only guards against re-entry.
+ *
+ */
 void RZLWidget::update() {
-    lastUpdated = "...";
+    if (fetching) {
+        saved_reentry++;
+        RZL_LOG_DEBUG("update re-entered, %ld requests saved", saved_reentry + saved_cooldown);
+        return;
+    }
+
+    if (rzl_in_cooldown(age_ms(lastFinished), lastSucceeded, lastFetchBearer, store.read().bearer)) {
+        saved_cooldown++;
+        RZL_LOG_DEBUG("update just finished, %ld requests saved", saved_reentry + saved_cooldown);
+        return;
+    }
+
+    fetching = true;
+    lastSucceeded = fetch();
+    fetching = false;
+    lastFinished = QDateTime::currentDateTime();
+    fetches++;
+
+    RZL_LOG_INFO("%ld requests made, %ld saved (%ld in cool-down, %ld re-entered)",
+                 fetches, saved_reentry + saved_cooldown, saved_cooldown, saved_reentry);
+}
+
+/*
+ * Makes a request and updates the status. Returns true on success (also
+ * when the status was not modified).
+ *
+ */
+bool RZLWidget::fetch() {
+    StatusSnapshot s;
+    do {
+        s = store.read();
+        s.lastUpdated = "...";
+    } while (!store.publish(s));
     repaint();
+    lastFetchBearer = s.bearer;
 
     /* Send a new HTTP request to get the status */
+    QTime started;
+    started.start();
+    setup_curl();
+    struct transfer_profile *profile = rzl_profile_for(s.bearer);
+    apply_profile(profile);
     CURLcode success = curl_easy_perform(hdl);
+    if (success != 0) {
+        RZL_LOG_ERR("Error updating status: %s", errbuf);
+        req_error();
+    } else {
+        long code = 0, filetime = -1;
+        curl_easy_getinfo(hdl, CURLINFO_RESPONSE_CODE, &code);
+        curl_easy_getinfo(hdl, CURLINFO_FILETIME, &filetime);
+        /* No body in a 304 response, so recv_status() was not called */
+        if (code == 304)
+            not_modified();
+        else if (filetime >= 0)
+            lastModified = filetime;
+    }
+
+    rzl_profile_account(profile, hdl, success);
+    if (LOG_INFO <= rzl_log_level) {
+        char report[LOG_MSG_SIZE];
+        rzl_profile_report(profile, report, sizeof(report));
+        RZL_LOG_INFO("%s", report);
+    }
+    rzl_trace("fetch %s %d %s", (success == 0 ? "ok" : "err"), started.elapsed(),
+              (success == 0 ? store.read().status.toAscii().data() : "?"));
+
     if (success == 0)
-        return;
+        rzl_tls_cache_save(share, false);
 
-    ULOG_ERR_L("Error updating status: %s", errbuf);
-    req_error();
+    if (!lean) {
+        idle_timer->start(KEEPALIVE_MS);
+        return (success == 0);
+    }
+
+    /* Release the transfer buffers until the next update */
+    release_curl();
+    rzl_memory_trim();
+
+    struct rzl_memusage usage;
+    if (!rzl_memory_usage(&usage))
+        return (success == 0);
+    RZL_LOG_INFO("memory usage: rss %ld kB, heap %ld kB", usage.rss_kb, usage.heap_kb);
+
+    /* The first update (with Qt, curl and the TLS library loaded and the
+     * handle released) is the baseline, see RSS_GROWTH_KB. Crossing the
+     * budget is logged once, not after every update. */
+    if (rss_budget_kb < 0)
+        rss_budget_kb = usage.rss_kb + RSS_GROWTH_KB;
+    bool within = (usage.rss_kb <= rss_budget_kb);
+    if (!within && !over_budget)
+        RZL_LOG_ERR("memory usage of %ld kB above the budget of %ld kB", usage.rss_kb, rss_budget_kb);
+    over_budget = !within;
+
+    return (success == 0);
 }
 
 void RZLWidget::receive_status(QString status) {
-    if (status == "1")
-        icon = icon_auf;
-    else if (status == "0")
-        icon = icon_zu;
-    else icon = icon_unklar;
-    lastUpdated = QDateTime::currentDateTime().toString("hh:mm");
+    StatusSnapshot s;
+    bool changed;
+    do {
+        s = store.read();
+        changed = (status != s.status);
+        s.status = status;
+        s.icon = icon_for(status);
+        s.lastFetched = QDateTime::currentDateTime();
+        s.lastUpdated = s.lastFetched.toString("hh:mm");
+    } while (!store.publish(s));
+
+    if (changed)
+        rzl_trace("server %s", status.toAscii().data());
+    repaint();
+}
+
+/*
+ * The status did not change since the last update (conditional request on
+ * a cellular connection). The icon might still show a failed update in
+ * between, so it is set from the confirmed status again.
+ *
+ */
+void RZLWidget::not_modified() {
+    StatusSnapshot s;
+    do {
+        s = store.read();
+        s.icon = icon_for(s.status);
+        s.lastFetched = QDateTime::currentDateTime();
+        s.lastUpdated = s.lastFetched.toString("hh:mm");
+    } while (!store.publish(s));
     repaint();
 }
 
 void RZLWidget::req_error() {
-    icon = icon_unklar;
-    lastUpdated = QDateTime::currentDateTime().toString("hh:mm");
+    StatusSnapshot s;
+    do {
+        s = store.read();
+        s.icon = ICON_UNKLAR;
+        s.lastUpdated = QDateTime::currentDateTime().toString("hh:mm");
+    } while (!store.publish(s));
     repaint();
 }
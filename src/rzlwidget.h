@@ -16,10 +16,13 @@
 #include <QtGui/qinputdialog.h>
 #include <QtGui/qpainter.h>
 #include <QTimer>
-#include <QIcon>
+#include <QPixmap>
 
 #include <curl/curl.h>
 
+#include "profile.h"
+#include "status.h"
+
 /* for conic (connection status) we need glib */
 #include <glib-object.h>
 #include <conic/conic.h>
@@ -31,22 +34,45 @@ class RZLWidget : public QWidget
 
 private:
     CURL *hdl;
+    CURLSH *share;
+    QByteArray url;
+    QByteArray cafile;
+    struct curl_slist *full_headers;
+    struct curl_slist *lean_headers;
+    /* Last-Modified of the status as sent by the server, -1 if unknown */
+    long lastModified;
     char errbuf[CURL_ERROR_SIZE];
     ConIcConnection *connection;
     QTimer *timer;
     QTimer *periodic_bearer;
-    QIcon *icon_unklar;
-    QIcon *icon_auf;
-    QIcon *icon_zu;
-    QIcon *icon;
-    QString lastBearer;
-    QString text;
-    QString lastUpdated;
+    /* closes the idle connection after an update, see trigger_release() */
+    QTimer *idle_timer;
+    QPixmap atlas;
+    /* lean mode: release the curl handle between fetches */
+    bool lean;
+    /* status, bearer and time of the last update, see status.h */
+    StatusStore store;
     int interval;
+    /* true while a request is running, see update() */
+    bool fetching;
+    /* when the last request finished, whether it succeeded and which bearer
+     * it was made on (see rzl_in_cooldown()) */
+    QDateTime lastFinished;
+    bool lastSucceeded;
+    QString lastFetchBearer;
+    /* number of requests made and saved by update() */
+    long fetches;
+    long saved_reentry;
+    long saved_cooldown;
+    /* lean mode: RSS budget in kB (-1 until the first update measured it)
+     * and whether it is currently exceeded, see fetch() */
+    long rss_budget_kb;
+    bool over_budget;
 
 public:
 
     RZLWidget(QWidget *parent = 0);
+    ~RZLWidget();
 
     QSize minimumSizeHint() const {
         return QSize(90, 90);
@@ -57,13 +83,22 @@ public:
     }
 
     void receive_status(QString status);
+    void not_modified();
     void req_error();
     void setConnection(QString bearer);
+    void display_on();
     void update();
 
+private:
+    bool fetch();
+    void setup_curl();
+    void apply_profile(struct transfer_profile *profile);
+    void release_curl();
+
 public slots:
     void trigger_update();
     void trigger_periodic();
+    void trigger_release();
 
 protected:
     void paintEvent(QPaintEvent *event);
@@ -0,0 +1,75 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#include "schedule.h"
+
+int rzl_update_interval(const QString &bearer) {
+    /* on wireless, update every 15 minutes */
+    if (bearer == "WLAN_INFRA")
+        return 15 * 60 * 1000;
+
+    /* on data connection, update every 30 minutes */
+    return 30 * 60 * 1000;
+}
+
+int rzl_first_update_delay(const QTime &now, const QString &bearer) {
+    QTime next = now;
+    int min;
+    int hr = next.hour();
+    int sec = 0;
+    int ms = 0;
+
+    if (bearer == "WLAN_INFRA") {
+        if (next.minute() < 45 && next.minute() >= 30)
+            min = 45;
+        else if (next.minute() < 30 && next.minute() >= 15)
+            min = 30;
+        else if (next.minute() < 15 && next.minute() >= 0)
+            min = 15;
+        else min = 60;
+    } else {
+        if (next.minute() >= 30)
+            min = 60;
+        else min = 30;
+    }
+
+    if (min == 60) {
+        if (hr == 23) {
+            min = 59;
+            sec = 59;
+            ms = 999;
+        } else {
+            min = 0;
+            hr = hr + 1;
+        }
+    }
+
+    next.setHMS(hr, min, sec, ms);
+    return now.msecsTo(next);
+}
+
+bool rzl_is_online(const QString &bearer) {
+    return (!bearer.isEmpty() && bearer != "offline");
+}
+
+bool rzl_should_revalidate(const QString &bearer, qint64 age_ms) {
+    if (!rzl_is_online(bearer))
+        return false;
+
+    return (age_ms < 0 || age_ms >= FRESH_SECS * 1000);
+}
+
+bool rzl_in_cooldown(qint64 age_ms, bool succeeded, const QString &fetch_bearer,
+                     const QString &bearer) {
+    if (!succeeded || fetch_bearer != bearer)
+        return false;
+
+    return (age_ms >= 0 && age_ms < COOLDOWN_SECS * 1000);
+}
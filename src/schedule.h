@@ -0,0 +1,70 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <QString>
+#include <QTime>
+
+/*
+ * The update schedule of the widget. This does not depend on the widget
+ * itself, so that the simulator (see sim/) can drive it in virtual time.
+ *
+ */
+
+/* A status younger than this (in seconds) is not revalidated on display on */
+#define FRESH_SECS (5 * 60)
+
+/* Updates triggered this shortly (in seconds) after a successful update on
+ * the same bearer reuse its result instead of making a new request */
+#define COOLDOWN_SECS 10
+
+/*
+ * Interval between two periodic updates on the given bearer, in
+ * milliseconds (15 minutes on wireless, 30 minutes on anything else).
+ *
+ */
+int rzl_update_interval(const QString &bearer);
+
+/*
+ * Milliseconds from now until the next full quarter (wireless) or half hour
+ * (any other bearer). After that, updates happen every
+ * rzl_update_interval() milliseconds.
+ *
+ */
+int rzl_first_update_delay(const QTime &now, const QString &bearer);
+
+/*
+ * Whether updates are possible on the bearer, that is, it is known and not
+ * offline.
+ *
+ */
+bool rzl_is_online(const QString &bearer);
+
+/*
+ * Whether the display turning on should trigger an update. age_ms is the
+ * time since the last successful update, -1 if there was none.
+ *
+ */
+bool rzl_should_revalidate(const QString &bearer, qint64 age_ms);
+
+/*
+ * Whether a trigger age_ms after the last update finished should reuse its
+ * result instead of making a new request. -1 means there was no update yet.
+ * Only a successful update made on the current bearer is reused: after an
+ * error (e.g. on a dying WLAN), a retry tap or the new bearer gets a new
+ * request.
+ *
+ */
+bool rzl_in_cooldown(qint64 age_ms, bool succeeded, const QString &fetch_bearer,
+                     const QString &bearer);
+
+#endif
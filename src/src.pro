@@ -1,14 +1,27 @@
 TEMPLATE = app
 
-QT += network
+# Only QtCore and QtGui are used, fetching is done with libcurl
+QT -= network
 
-SOURCES += main.cpp rzlwidget.cpp
-HEADERS += rzlwidget.h
+SOURCES += main.cpp rzlwidget.cpp memusage.cpp schedule.cpp trace.cpp profile.cpp log.cpp status.cpp tlscache.cpp
+HEADERS += rzlwidget.h memusage.h schedule.h trace.h profile.h log.h status.h tlscache.h
 CONFIG += link_pkgconfig
 PKGCONFIG += glib-2.0 conic
 TARGET = raumzeitlabor-status
 
-QMAKE_LFLAGS += -lcurl
+QMAKE_LFLAGS += -lcurl -lpthread
+
+# "qmake CONFIG+=https" fetches the status via HTTPS
+https {
+    DEFINES += RZL_HTTPS
+}
+
+# "qmake CONFIG+=lean" builds the memory-lean variant: the curl handle is
+# released between fetches and unused libraries are not linked in
+lean {
+    DEFINES += RZL_LEAN
+    QMAKE_LFLAGS += -Wl,--as-needed
+}
 
 include(../qmaemo5homescreenadaptor/qmaemo5homescreenadaptor.pri)
 
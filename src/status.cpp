@@ -0,0 +1,62 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#include <sched.h>
+
+#include "status.h"
+
+StatusStore::StatusStore() : current(0) {
+    readers[0] = 0;
+    readers[1] = 0;
+}
+
+StatusSnapshot StatusStore::read() const {
+    int idx;
+
+    /* Announce ourselves as a reader of the current buffer. If a writer
+     * switched buffers in the meantime, it might be overwriting the one we
+     * picked, so we try again. */
+    while (true) {
+        idx = current.fetchAndAddOrdered(0);
+        readers[idx].ref();
+        if (current.fetchAndAddOrdered(0) == idx)
+            break;
+        readers[idx].deref();
+    }
+
+    StatusSnapshot snapshot = buffers[idx];
+    readers[idx].deref();
+
+    return snapshot;
+}
+
+unsigned long StatusStore::publish(const StatusSnapshot &next) {
+    QMutexLocker locker(&write_mutex);
+
+    int idx = current.fetchAndAddOrdered(0);
+    int other = 1 - idx;
+
+    /* next was based on an older snapshot, the writer has to start over */
+    if (next.version != buffers[idx].version)
+        return 0;
+
+    /* Wait for readers which picked the other buffer before the last
+     * switch. Reading a snapshot is short, so this is rare. */
+    while (readers[other].fetchAndAddOrdered(0) != 0)
+        sched_yield();
+
+    unsigned long version = buffers[idx].version + 1;
+    buffers[other] = next;
+    buffers[other].version = version;
+
+    current.fetchAndStoreOrdered(other);
+
+    return version;
+}
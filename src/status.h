@@ -0,0 +1,97 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <QString>
+#include <QDateTime>
+#include <QAtomicInt>
+#include <QMutex>
+
+/* Index of the status icon in the icon pixmap */
+enum {
+    ICON_UNKLAR = 0,
+    ICON_AUF = 1,
+    ICON_ZU = 2,
+    ICON_COUNT = 3
+};
+
+/*
+ * Everything the widget knows about the status at one point in time. A
+ * snapshot is never modified after it was published, writers build a new
+ * one instead.
+ *
+ */
+struct StatusSnapshot {
+    /* incremented with every published snapshot */
+    unsigned long version;
+    /* ICON_UNKLAR, ICON_AUF or ICON_ZU */
+    int icon;
+    /* last status received from the server (1, 0 or something else) */
+    QString status;
+    /* text below the icon (time of the last update, ... while updating) */
+    QString lastUpdated;
+    /* time of the last successful update, invalid if there was none */
+    QDateTime lastFetched;
+    /* current bearer (WLAN_INFRA, offline, …), empty if not known yet */
+    QString bearer;
+
+    StatusSnapshot() : version(0), icon(ICON_UNKLAR), lastUpdated("?") {}
+};
+
+/*
+ * Holds the current StatusSnapshot for the fetcher, the renderer and any
+ * other reader, which may live in different threads.
+ *
+ * There are two buffers: readers use the current one, a writer fills the
+ * other one and then switches the current index. Readers never block, they
+ * only retry if a switch happens while they pick a buffer. Writers are
+ * serialized and wait for readers still holding the buffer they are about
+ * to overwrite.
+ *
+ */
+class StatusStore
+{
+private:
+    StatusSnapshot buffers[2];
+    /* number of readers currently using each buffer */
+    mutable QAtomicInt readers[2];
+    /* index of the current buffer */
+    mutable QAtomicInt current;
+    QMutex write_mutex;
+
+public:
+    StatusStore();
+
+    /*
+     * Returns a copy of the current snapshot.
+     *
+     */
+    StatusSnapshot read() const;
+
+    /*
+     * Publishes next as the current snapshot and returns the version it was
+     * given. next must be a changed copy of the current snapshot: if another
+     * writer published in the meantime (next.version is outdated), nothing
+     * is published and 0 is returned, so that no update gets lost. Writers
+     * therefore retry:
+     *
+     *   StatusSnapshot s;
+     *   do {
+     *       s = store.read();
+     *       s.icon = ICON_AUF;
+     *   } while (!store.publish(s));
+     *
+     */
+    unsigned long publish(const StatusSnapshot &next);
+};
+
+#endif
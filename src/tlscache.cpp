@@ -0,0 +1,206 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tlscache.h"
+#include "log.h"
+
+/* curl_easy_ssls_export() and curl_easy_ssls_import() exist since 8.12.0 */
+#if LIBCURL_VERSION_NUM >= 0x080c00
+
+/*
+ * The file starts with TLS_CACHE_HEADER, followed by one record per session:
+ * the session key, the salted hash and the session data (each as a 32 bit
+ * length and the bytes), then the expiry time as 64 bit seconds since the
+ * epoch. An empty session key stands for none (libcurl only exports the hash
+ * for some sessions). Integers are in host byte order.
+ *
+ */
+#define TLS_CACHE_HEADER "# rzl-tls 1\n"
+/* Longer fields are treated as a corrupt file */
+#define TLS_CACHE_MAX_FIELD (64 * 1024)
+
+static time_t last_save = 0;
+
+static const char *cache_path() {
+    static char path[256];
+
+    const char *env = getenv("RZL_TLS_CACHE");
+    if (env != NULL)
+        return (*env == '\0' ? NULL : env);
+
+    const char *home = getenv("HOME");
+    if (home == NULL)
+        return NULL;
+    snprintf(path, sizeof(path), "%s/.raumzeitlabor-status.tls", home);
+    return path;
+}
+
+static bool write_field(FILE *f, const void *data, size_t len) {
+    uint32_t n = len;
+    return (fwrite(&n, sizeof(n), 1, f) == 1 && (len == 0 || fwrite(data, len, 1, f) == 1));
+}
+
+/*
+ * Reads a field into a newly allocated buffer, which is NUL-terminated so
+ * that the session key can be used as a string. Returns NULL at the end of
+ * the file or if the field is corrupt.
+ *
+ */
+static unsigned char *read_field(FILE *f, size_t *len) {
+    uint32_t n;
+    if (fread(&n, sizeof(n), 1, f) != 1 || n > TLS_CACHE_MAX_FIELD)
+        return NULL;
+
+    unsigned char *buf = (unsigned char*)malloc(n + 1);
+    if (buf == NULL)
+        return NULL;
+    if (n > 0 && fread(buf, n, 1, f) != 1) {
+        free(buf);
+        return NULL;
+    }
+    buf[n] = '\0';
+    *len = n;
+    return buf;
+}
+
+static CURLcode export_session(CURL *hdl, void *userptr, const char *session_key,
+                               const unsigned char *shmac, size_t shmac_len,
+                               const unsigned char *sdata, size_t sdata_len,
+                               curl_off_t valid_until, int ietf_tls_id, const char *alpn,
+                               size_t earlydata_max) {
+    (void)hdl;
+    (void)ietf_tls_id;
+    (void)alpn;
+    (void)earlydata_max;
+
+    FILE *f = (FILE*)userptr;
+    int64_t until = valid_until;
+    if (!write_field(f, session_key, (session_key != NULL ? strlen(session_key) : 0)) ||
+        !write_field(f, shmac, shmac_len) ||
+        !write_field(f, sdata, sdata_len) ||
+        fwrite(&until, sizeof(until), 1, f) != 1)
+        return CURLE_WRITE_ERROR;
+
+    return CURLE_OK;
+}
+
+void rzl_tls_cache_load(CURLSH *share) {
+    const char *path = cache_path();
+    if (path == NULL)
+        return;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return;
+
+    char header[sizeof(TLS_CACHE_HEADER)];
+    size_t header_len = strlen(TLS_CACHE_HEADER);
+    if (fread(header, header_len, 1, f) != 1 || memcmp(header, TLS_CACHE_HEADER, header_len) != 0) {
+        fclose(f);
+        return;
+    }
+
+    /* Sessions are imported through a temporary handle, they end up in the
+     * share object and outlive it */
+    CURL *hdl = curl_easy_init();
+    curl_easy_setopt(hdl, CURLOPT_SHARE, share);
+
+    time_t now = time(NULL);
+    int imported = 0;
+    bool ok;
+    do {
+        unsigned char *key = NULL, *shmac = NULL, *sdata = NULL;
+        size_t key_len = 0, shmac_len = 0, sdata_len = 0;
+        int64_t until = 0;
+
+        ok = ((key = read_field(f, &key_len)) != NULL &&
+              (shmac = read_field(f, &shmac_len)) != NULL &&
+              (sdata = read_field(f, &sdata_len)) != NULL &&
+              fread(&until, sizeof(until), 1, f) == 1);
+        if (ok && until > now &&
+            curl_easy_ssls_import(hdl, (key_len > 0 ? (const char*)key : NULL),
+                                  shmac, shmac_len, sdata, sdata_len) == CURLE_OK)
+            imported++;
+
+        free(key);
+        free(shmac);
+        free(sdata);
+    } while (ok);
+
+    curl_easy_cleanup(hdl);
+    fclose(f);
+
+    RZL_LOG_INFO("imported %d TLS sessions from %s", imported, path);
+}
+
+void rzl_tls_cache_save(CURLSH *share, bool force) {
+    time_t now = time(NULL);
+    if (!force && last_save != 0 && now - last_save < TLS_CACHE_SAVE_SECS)
+        return;
+
+    const char *path = cache_path();
+    if (path == NULL)
+        return;
+    last_save = now;
+
+    /* Write a temporary file and rename it, so that the cache is never left
+     * half-written */
+    char tmp_path[300];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    unlink(tmp_path);
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return;
+
+    FILE *f = fdopen(fd, "wb");
+    if (f == NULL) {
+        close(fd);
+        unlink(tmp_path);
+        return;
+    }
+    fputs(TLS_CACHE_HEADER, f);
+
+    CURL *hdl = curl_easy_init();
+    curl_easy_setopt(hdl, CURLOPT_SHARE, share);
+    CURLcode result = curl_easy_ssls_export(hdl, export_session, f);
+    curl_easy_cleanup(hdl);
+
+    if (fclose(f) != 0 && result == CURLE_OK)
+        result = CURLE_WRITE_ERROR;
+    if (result != CURLE_OK) {
+        unlink(tmp_path);
+        RZL_LOG_INFO("could not save TLS sessions: %s", curl_easy_strerror(result));
+        return;
+    }
+
+    if (rename(tmp_path, path) != 0)
+        unlink(tmp_path);
+}
+
+#else
+
+void rzl_tls_cache_load(CURLSH *share) {
+    (void)share;
+}
+
+void rzl_tls_cache_save(CURLSH *share, bool force) {
+    (void)share;
+    (void)force;
+}
+
+#endif
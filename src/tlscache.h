@@ -0,0 +1,47 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#ifndef TLSCACHE_H
+#define TLSCACHE_H
+
+#include <curl/curl.h>
+
+/*
+ * Keeps the TLS sessions of the curl share object across restarts of the
+ * widget, so that the first update after a reboot resumes the session
+ * instead of doing a full handshake.
+ *
+ * Exporting sessions needs libcurl 8.12.0 or later (built with SSLS-EXPORT),
+ * with older versions (such as the 7.x on Maemo) these functions do nothing.
+ *
+ * The sessions are stored in the file named by RZL_TLS_CACHE, which defaults
+ * to ~/.raumzeitlabor-status.tls. An empty RZL_TLS_CACHE disables the cache.
+ * The file is only readable by its owner, it contains session secrets.
+ *
+ */
+
+/* Sessions are written at most this often (in seconds), unless forced */
+#define TLS_CACHE_SAVE_SECS (60 * 60)
+
+/*
+ * Imports the stored sessions (except for expired ones) into share, which
+ * has to share CURL_LOCK_DATA_SSL_SESSION.
+ *
+ */
+void rzl_tls_cache_load(CURLSH *share);
+
+/*
+ * Stores the sessions of share. Unless force is true, this does nothing when
+ * the last save was less than TLS_CACHE_SAVE_SECS ago.
+ *
+ */
+void rzl_tls_cache_save(CURLSH *share, bool force);
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <sys/time.h>
+
+#include "trace.h"
+
+static FILE *trace_file = NULL;
+
+void rzl_trace_open() {
+    const char *path = getenv("RZL_TRACE");
+    if (path == NULL || *path == '\0' || trace_file != NULL)
+        return;
+
+    if ((trace_file = fopen(path, "a")) == NULL)
+        return;
+
+    setvbuf(trace_file, NULL, _IOLBF, 0);
+    fprintf(trace_file, "%s\n", TRACE_HEADER);
+}
+
+bool rzl_trace_enabled() {
+    return (trace_file != NULL);
+}
+
+void rzl_trace(const char *fmt, ...) {
+    if (trace_file == NULL)
+        return;
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    fprintf(trace_file, "%lld ", (long long)tv.tv_sec * 1000 + tv.tv_usec / 1000);
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(trace_file, fmt, args);
+    va_end(args);
+
+    fputc('\n', trace_file);
+}
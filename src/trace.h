@@ -0,0 +1,42 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * Records a trace of everything the update schedule depends on, so that it
+ * can be replayed by the simulator in sim/. Tracing is enabled by setting
+ * RZL_TRACE to the path of the trace file.
+ *
+ * The trace is a text file with one event per line, the first column is the
+ * time in milliseconds since the epoch:
+ *
+ *   <ms> conn <bearer>                   connection_change (bearer or offline)
+ *   <ms> stats <bearer>                  connection_statistics
+ *   <ms> fetch <ok|err> <latency> <st>   result of an update (st: 1, 0 or ?)
+ *   <ms> server <st>                     the server status changed to st
+ *   <ms> display on                      display turned on / device unlocked
+ *
+ * Lines starting with # are comments.
+ *
+ * server events are only written when the widget itself fetched a changed
+ * status, so they lag behind the real transitions by up to one update
+ * interval. sim/probe.sh records a ground truth trace (server events only)
+ * by polling at a high rate.
+ *
+ */
+#define TRACE_HEADER "# rzl-trace 1"
+
+void rzl_trace_open();
+bool rzl_trace_enabled();
+void rzl_trace(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget — tests
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ * Runs all tests, exits with status 1 if one of them fails. Use
+ * "make check" to build and run them.
+ *
+ */
+#include <stdio.h>
+
+#include "tests.h"
+
+struct test {
+    const char *name;
+    bool (*run)();
+};
+
+static struct test tests[] = {
+    /* first, before the stress test grows the heap */
+    { "memory usage", test_memusage },
+    { "status store", test_status_store },
+};
+
+int main() {
+    int failed = 0;
+
+    for (unsigned int c = 0; c < sizeof(tests) / sizeof(tests[0]); c++) {
+        bool ok = tests[c].run();
+        printf("%-20s %s\n", tests[c].name, (ok ? "ok" : "FAILED"));
+        if (!ok)
+            failed++;
+    }
+
+    return (failed > 0 ? 1 : 0);
+}
@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# Stand-in for MCE (the mode control entity) to test the revalidation of
+# the status when the display turns on, without a device.
+#
+# Conic does not work on the private bus, so the widget has to be told the
+# bearer with RZL_BEARER:
+#
+#   eval $(tests/mce-standin.sh start)
+#   RZL_BEARER=WLAN_INFRA RZL_LOG_LEVEL=info RZL_LOG_FILE=/tmp/rzl.log \
+#       raumzeitlabor-status &
+#   tests/mce-standin.sh display on
+#   tests/mce-standin.sh tklock unlocked
+#   tests/mce-standin.sh stop
+#
+# "start" runs a private bus and prints the shell commands to point
+# DBUS_SYSTEM_BUS_ADDRESS at it.
+#
+set -e
+
+MCE_SIGNAL_PATH=/com/nokia/mce/signal
+MCE_SIGNAL_IF=com.nokia.mce.signal
+
+emit() {
+    if [ -z "$DBUS_SYSTEM_BUS_ADDRESS" ]; then
+        echo "DBUS_SYSTEM_BUS_ADDRESS is not set, run: eval \$($0 start)" >&2
+        exit 1
+    fi
+    dbus-send --system --type=signal "$MCE_SIGNAL_PATH" "$MCE_SIGNAL_IF.$1" "string:$2"
+}
+
+case "$1" in
+    start)
+        out=$(dbus-daemon --session --fork --print-address=1 --print-pid=1)
+        address=$(echo "$out" | sed -n 1p)
+        pid=$(echo "$out" | sed -n 2p)
+        echo "DBUS_SYSTEM_BUS_ADDRESS='$address'; export DBUS_SYSTEM_BUS_ADDRESS;"
+        echo "MCE_STANDIN_PID=$pid; export MCE_STANDIN_PID;"
+        ;;
+    stop)
+        [ -n "$MCE_STANDIN_PID" ] && kill "$MCE_STANDIN_PID"
+        ;;
+    display)
+        # on, off or dimmed
+        emit display_status_ind "${2:-on}"
+        ;;
+    tklock)
+        # locked or unlocked
+        emit tklock_mode_ind "${2:-unlocked}"
+        ;;
+    *)
+        echo "Syntax: $0 start|stop|display <on|off|dimmed>|tklock <locked|unlocked>" >&2
+        exit 1
+        ;;
+esac
@@ -0,0 +1,53 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget — tests
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ * Checks the memory reporting hook: heap memory released after a
+ * transfer-sized allocation has to show up as released, and must not count
+ * against the widget's RSS growth margin (see RSS_GROWTH_KB). The budget
+ * itself is derived by the widget at runtime, so it is not checked here.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "memusage.h"
+#include "tests.h"
+
+#define CHUNKS 64
+#define CHUNK_SIZE (64 * 1024)
+
+bool test_memusage() {
+    struct rzl_memusage before, during, after;
+
+    CHECK(rzl_memory_usage(&before), "could not read /proc/self/statm");
+    CHECK(before.rss_kb > 0, "rss is %ld kB", before.rss_kb);
+    CHECK(!rzl_memory_within_budget(1), "rss of %ld kB reported within 1 kB", before.rss_kb);
+
+    char *chunks[CHUNKS];
+    for (int c = 0; c < CHUNKS; c++) {
+        chunks[c] = (char*)malloc(CHUNK_SIZE);
+        memset(chunks[c], c, CHUNK_SIZE);
+    }
+    rzl_memory_usage(&during);
+    for (int c = 0; c < CHUNKS; c++)
+        free(chunks[c]);
+    rzl_memory_trim();
+    rzl_memory_usage(&after);
+
+    long allocated_kb = CHUNKS * CHUNK_SIZE / 1024;
+    CHECK(during.heap_kb >= before.heap_kb + allocated_kb,
+          "heap grew by %ld kB, expected %ld kB", during.heap_kb - before.heap_kb, allocated_kb);
+    CHECK(after.heap_kb < before.heap_kb + allocated_kb / 8,
+          "heap still %ld kB above the start after freeing", after.heap_kb - before.heap_kb);
+    CHECK(rzl_memory_within_budget(before.rss_kb + RSS_GROWTH_KB),
+          "rss grew by %ld kB after freeing, the margin is %d kB",
+          after.rss_kb - before.rss_kb, RSS_GROWTH_KB);
+
+    return true;
+}
@@ -0,0 +1,133 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget — tests
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ * Stress test for StatusStore: status writers (like the fetcher) and bearer
+ * writers (like the conic callbacks) count up concurrently while readers
+ * (like paintEvent()) check every snapshot they get.
+ *
+ * Every writer keeps the fields in a fixed relationship:
+ *  - status is the number of status updates so far,
+ *  - lastUpdated is "<status> updates",
+ *  - bearer is the number of bearer updates so far,
+ *  - version is the sum of both, since every publish increments it.
+ *
+ * A torn snapshot breaks one of these relationships, a lost update makes
+ * the final counts too small.
+ *
+ */
+#include <QThread>
+#include <QAtomicInt>
+
+#include "status.h"
+#include "tests.h"
+
+#define STATUS_WRITERS 3
+#define BEARER_WRITERS 3
+#define READERS 4
+#define UPDATES_PER_WRITER 20000
+
+class WriterThread : public QThread
+{
+public:
+    StatusStore *store;
+    bool bearer;
+
+    void run() {
+        for (int c = 0; c < UPDATES_PER_WRITER; c++) {
+            StatusSnapshot s;
+            do {
+                s = store->read();
+                if (bearer) {
+                    s.bearer = QString::number(s.bearer.toLong() + 1);
+                } else {
+                    long updates = s.status.toLong() + 1;
+                    s.status = QString::number(updates);
+                    s.lastUpdated = QString("%1 updates").arg(updates);
+                    s.icon = updates % ICON_COUNT;
+                }
+            } while (!store->publish(s));
+        }
+    }
+};
+
+class ReaderThread : public QThread
+{
+public:
+    StatusStore *store;
+    QAtomicInt *stop;
+    long reads;
+    long torn;
+    long backwards;
+
+    void run() {
+        unsigned long last = 0;
+        reads = torn = backwards = 0;
+
+        while (stop->fetchAndAddOrdered(0) == 0) {
+            StatusSnapshot s = store->read();
+            reads++;
+
+            if (s.version < last)
+                backwards++;
+            last = s.version;
+
+            /* the initial snapshot has no counters yet */
+            if (s.version == 0)
+                continue;
+            long updates = s.status.toLong();
+            if (s.lastUpdated != QString("%1 updates").arg(updates) ||
+                s.icon != updates % ICON_COUNT ||
+                s.version != (unsigned long)(updates + s.bearer.toLong()))
+                torn++;
+        }
+    }
+};
+
+bool test_status_store() {
+    StatusStore store;
+    QAtomicInt stop(0);
+    WriterThread writers[STATUS_WRITERS + BEARER_WRITERS];
+    ReaderThread readers[READERS];
+
+    for (int c = 0; c < READERS; c++) {
+        readers[c].store = &store;
+        readers[c].stop = &stop;
+        readers[c].start();
+    }
+    for (int c = 0; c < STATUS_WRITERS + BEARER_WRITERS; c++) {
+        writers[c].store = &store;
+        writers[c].bearer = (c >= STATUS_WRITERS);
+        writers[c].start();
+    }
+
+    for (int c = 0; c < STATUS_WRITERS + BEARER_WRITERS; c++)
+        writers[c].wait();
+    stop.fetchAndStoreOrdered(1);
+    for (int c = 0; c < READERS; c++)
+        readers[c].wait();
+
+    for (int c = 0; c < READERS; c++) {
+        CHECK(readers[c].reads > 0, "reader %d did not read anything", c);
+        CHECK(readers[c].torn == 0, "reader %d got %ld torn snapshots", c, readers[c].torn);
+        CHECK(readers[c].backwards == 0, "reader %d saw the version go back %ld times",
+              c, readers[c].backwards);
+    }
+
+    StatusSnapshot s = store.read();
+    long status_updates = STATUS_WRITERS * UPDATES_PER_WRITER;
+    long bearer_updates = BEARER_WRITERS * UPDATES_PER_WRITER;
+    CHECK(s.status.toLong() == status_updates, "%ld of %ld status updates lost",
+          status_updates - s.status.toLong(), status_updates);
+    CHECK(s.bearer.toLong() == bearer_updates, "%ld of %ld bearer updates lost",
+          bearer_updates - s.bearer.toLong(), bearer_updates);
+    CHECK(s.version == (unsigned long)(status_updates + bearer_updates),
+          "version is %lu, expected %ld", s.version, status_updates + bearer_updates);
+
+    return true;
+}
@@ -0,0 +1,30 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * RaumZeitLabor status widget — tests
+ *
+ * © 2010 Michael Stapelberg
+ *
+ * See LICENSE for licensing information
+ *
+ */
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <stdio.h>
+
+/* Prints a message and makes the test fail if cond is false */
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__); \
+            fprintf(stderr, "\n"); \
+            return false; \
+        } \
+    } while (0)
+
+bool test_memusage();
+bool test_status_store();
+
+#endif
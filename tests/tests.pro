@@ -0,0 +1,16 @@
+TEMPLATE = app
+
+# The tests only need QtCore, they are not installed
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../src
+SOURCES += main.cpp test_memusage.cpp test_status.cpp ../src/memusage.cpp ../src/status.cpp
+HEADERS += tests.h ../src/memusage.h ../src/status.h
+TARGET = rzl-tests
+
+# "make check" runs the tests
+check.depends = $$TARGET
+check.commands = ./$$TARGET
+QMAKE_EXTRA_TARGETS += check